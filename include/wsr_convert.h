@@ -0,0 +1,664 @@
+#ifndef WAVE_STRUCTURE_CONVERTER_H
+#define WAVE_STRUCTURE_CONVERTER_H
+
+#include "wsr.h"
+#include "wsr_parallel.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <sys/stat.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+  #include <tmmintrin.h>
+  #define WSR_SIMD_SSSE3
+#elif defined(__ARM_NEON)
+  #include <arm_neon.h>
+  #define WSR_SIMD_NEON
+#endif
+
+/* Streaming block size for sample data and pass-through chunks. */
+#define WSR_CONVERT_BLOCK (1 << 20)
+
+/* Sample formats whose data is a plain sequence of words. */
+#define WSR_FORMAT_PCM 1
+#define WSR_FORMAT_IEEE_FLOAT 3
+
+/* Conversion state. In-place conversion uses the same stream for both. */
+typedef struct {
+  FILE *in;
+  FILE *out;
+  long pos;             /* Read position within `in`. */
+  uint16_t num_channels;
+  uint16_t block_align;
+  uint16_t bits_per_sample;
+  uint16_t audio_format;
+  int swap_data;        /* PCM or float, other data is copied as is. */
+  uint8_t *block;       /* Streaming buffer, WSR_CONVERT_BLOCK bytes. */
+} wsr_converter;
+
+/* Cursor over a buffered chunk, mirrors the reads made by the decoders. */
+typedef struct {
+  uint8_t *data;
+  size_t size;
+  size_t pos;
+} wsr_cursor;
+
+/* Reverse a single field in place and return its converted value (fields
+   wider than four bytes return 0). Out-of-bounds fields are left alone. */
+uint32_t wsr_cv_swap(wsr_cursor *cur, size_t size) {
+  uint32_t value = 0;
+  if (cur->pos + size <= cur->size) {
+    uint8_t *field = cur->data + cur->pos;
+    for (size_t i = 0; i < size / 2; i++) {
+      uint8_t temp = field[i];
+      field[i] = field[size - 1 - i];
+      field[size - 1 - i] = temp;
+    }
+    if (size <= sizeof(value)) {
+      memcpy(&value, field, size);
+    }
+  }
+  cur->pos += size;
+  return value;
+}
+
+/* Skip over byte-oriented fields (text, reserved). */
+void wsr_cv_skip(wsr_cursor *cur, size_t size) { cur->pos += size; }
+
+/* Scalar fallback, reverses every `width`-byte word. */
+void wsr_bswap_scalar(uint8_t *buf, size_t len, size_t width) {
+  for (size_t off = 0; off + width <= len; off += width) {
+    uint8_t *word = buf + off;
+    for (size_t i = 0; i < width / 2; i++) {
+      uint8_t temp = word[i];
+      word[i] = word[width - 1 - i];
+      word[width - 1 - i] = temp;
+    }
+  }
+}
+
+#if defined(WSR_SIMD_SSSE3)
+/* Returns the number of bytes swapped, the tail is left to the caller. */
+__attribute__((target("ssse3"))) size_t wsr_bswap_ssse3(uint8_t *buf,
+                                                        size_t len,
+                                                        size_t width) {
+  __m128i mask;
+  size_t step = 16;
+
+  /* clang-format off */
+  switch (width) {
+    case 2: mask = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14); break;
+    case 4: mask = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12); break;
+    case 8: mask = _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8); break;
+    case 3: {
+      /* Four 24-bit words per register, the last four bytes are rewritten
+         unchanged and picked up again by the next iteration. */
+      mask = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 12, 13, 14, 15);
+      step = 12;
+      break;
+    }
+    default: return 0;
+  }
+  /* clang-format on */
+
+  size_t off = 0;
+  for (; off + 16 <= len; off += step) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(buf + off));
+    _mm_storeu_si128((__m128i *)(buf + off), _mm_shuffle_epi8(v, mask));
+  }
+  return off;
+}
+#elif defined(WSR_SIMD_NEON)
+/* Returns the number of bytes swapped, the tail is left to the caller. */
+size_t wsr_bswap_neon(uint8_t *buf, size_t len, size_t width) {
+  size_t off = 0;
+  switch (width) {
+  case 2:
+    for (; off + 16 <= len; off += 16) {
+      vst1q_u8(buf + off, vrev16q_u8(vld1q_u8(buf + off)));
+    }
+    break;
+  case 4:
+    for (; off + 16 <= len; off += 16) {
+      vst1q_u8(buf + off, vrev32q_u8(vld1q_u8(buf + off)));
+    }
+    break;
+  case 8:
+    for (; off + 16 <= len; off += 16) {
+      vst1q_u8(buf + off, vrev64q_u8(vld1q_u8(buf + off)));
+    }
+    break;
+  case 3:
+    /* De-interleave sixteen 24-bit words and swap the outer byte lanes. */
+    for (; off + 48 <= len; off += 48) {
+      uint8x16x3_t v = vld3q_u8(buf + off);
+      uint8x16_t temp = v.val[0];
+      v.val[0] = v.val[2];
+      v.val[2] = temp;
+      vst3q_u8(buf + off, v);
+    }
+    break;
+  default:
+    break;
+  }
+  return off;
+}
+#endif
+
+/* Byte-swap every `width`-byte sample word in the buffer. */
+void wsr_bswap_samples(uint8_t *buf, size_t len, size_t width) {
+  if (width < 2) {
+    return; /* 8-bit samples have no byte order. */
+  }
+
+  size_t done = 0;
+#if defined(WSR_SIMD_SSSE3)
+  if (__builtin_cpu_supports("ssse3")) {
+    done = wsr_bswap_ssse3(buf, len, width);
+  }
+#elif defined(WSR_SIMD_NEON)
+  done = wsr_bswap_neon(buf, len, width);
+#endif
+  wsr_bswap_scalar(buf + done, len - done, width);
+}
+
+/* Read the next `size` bytes of input. */
+size_t wsr_cv_read(wsr_converter *cv, void *buf, size_t size) {
+  if (cv->in == cv->out) {
+    fseek(cv->in, cv->pos, SEEK_SET);
+  }
+  size_t read = fread(buf, 1, size, cv->in);
+  cv->pos += read;
+  return read;
+}
+
+/* Write `size` bytes that were read from `at` (only used for in-place). */
+int wsr_cv_write(wsr_converter *cv, const void *buf, size_t size, long at) {
+  if (cv->in == cv->out) {
+    fseek(cv->out, at, SEEK_SET);
+  }
+  return fwrite(buf, 1, size, cv->out) == size ? 0 : -1;
+}
+
+/* Copy or swap `size` bytes of input to output in large blocks. */
+int wsr_cv_stream(wsr_converter *cv, uint8_t *block, size_t size,
+                  size_t width) {
+  /* Unchanged bytes do not have to be rewritten in place. */
+  if (width < 2 && cv->in == cv->out) {
+    cv->pos += size;
+    return 0;
+  }
+
+  /* Keep blocks sample aligned so no word is split between reads. */
+  size_t block_size = WSR_CONVERT_BLOCK;
+  if (width > 1) {
+    block_size -= block_size % width;
+  }
+
+  while (size > 0) {
+    size_t want = size < block_size ? size : block_size;
+    long at = cv->pos;
+    size_t got = wsr_cv_read(cv, block, want);
+    if (got != want) {
+      fprintf(stderr, "Unexpected end of file at offset %ld.\n", cv->pos);
+      return -1;
+    }
+
+    wsr_bswap_samples(block, got, width);
+    if (wsr_cv_write(cv, block, got, at) != 0) {
+      perror("Error writing output");
+      return -1;
+    }
+    size -= got;
+  }
+  return 0;
+}
+
+/* Range kernel for the parallel data pass. */
+void wsr_cv_range_swap(wsr_range *range, uint8_t *buf, size_t len) {
+  wsr_bswap_samples(buf, len, *(const size_t *)range->arg);
+}
+
+/* Whether sample data at `at` can be rewritten through pread/pwrite, i.e.
+   both sides are regular files and the output mirrors the input layout. */
+int wsr_cv_direct(wsr_converter *cv, long at) {
+  struct stat in_st, out_st;
+  if (fstat(fileno(cv->in), &in_st) != 0 || !S_ISREG(in_st.st_mode)) {
+    return 0;
+  }
+  if (cv->in == cv->out) {
+    return 1;
+  }
+
+  int flags = fcntl(fileno(cv->out), F_GETFL);
+  return fstat(fileno(cv->out), &out_st) == 0 && S_ISREG(out_st.st_mode) &&
+         flags != -1 && !(flags & O_APPEND) && ftell(cv->out) == at;
+}
+
+/* Swap a large data chunk with one thread per frame-aligned range. */
+int wsr_cv_parallel(wsr_converter *cv, size_t size, size_t width,
+                    unsigned threads) {
+  /* Buffered header writes must land before the threads touch the file. */
+  if (fflush(cv->out) != 0) {
+    perror("Error writing output");
+    return -1;
+  }
+
+  /* Split on whole frames when the layout allows it, else on samples. */
+  size_t frame = cv->block_align != 0 && cv->block_align % width == 0
+                     ? cv->block_align
+                     : width;
+
+  wsr_range ranges[WSR_PARALLEL_MAX_THREADS];
+  if (wsr_split_ranges(ranges, threads, cv->pos, size, frame) != 0) {
+    fprintf(stderr, "Invalid frame size. Exiting.\n");
+    return -1;
+  }
+  for (unsigned i = 0; i < threads; i++) {
+    ranges[i].in_fd = fileno(cv->in);
+    ranges[i].out_fd = fileno(cv->out);
+    ranges[i].kernel = wsr_cv_range_swap;
+    ranges[i].arg = &width;
+    ranges[i].state = NULL;
+  }
+
+  if (wsr_run_ranges(ranges, threads) != 0) {
+    /* Report the first failure in file order. */
+    for (unsigned i = 0; i < threads; i++) {
+      if (ranges[i].status == 0) {
+        continue;
+      }
+      if (ranges[i].error == 0) {
+        fprintf(stderr, "Unexpected end of file at offset %lld.\n",
+                (long long)ranges[i].error_at);
+      } else {
+        errno = ranges[i].error;
+        perror("Error converting data");
+      }
+      return -1;
+    }
+  }
+
+  /* Resynchronise the stdio streams with the data written behind them. */
+  cv->pos += size;
+  if (fseek(cv->in, cv->pos, SEEK_SET) != 0 ||
+      (cv->in != cv->out && fseek(cv->out, cv->pos, SEEK_SET) != 0)) {
+    perror("Error seeking");
+    return -1;
+  }
+  return 0;
+}
+
+/* Copy everything up to EOF unchanged, e.g. bytes after the RIFF size. */
+int wsr_cv_copy_rest(wsr_converter *cv, uint8_t *block) {
+  if (cv->in == cv->out) {
+    return 0;
+  }
+
+  /* The walker may have read a partial header past this point. */
+  if (fseek(cv->in, cv->pos, SEEK_SET) != 0) {
+    perror("Error seeking");
+    return -1;
+  }
+
+  size_t got;
+  while ((got = wsr_cv_read(cv, block, WSR_CONVERT_BLOCK)) > 0) {
+    if (wsr_cv_write(cv, block, got, cv->pos - got) != 0) {
+      perror("Error writing output");
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/* Copy the pad byte of an odd-sized chunk, tolerating its absence at EOF. */
+int wsr_cv_pad(wsr_converter *cv, size_t pad) {
+  if (pad == 0 || cv->in == cv->out) {
+    cv->pos += pad;
+    return 0;
+  }
+
+  long at = cv->pos;
+  uint8_t byte;
+  if (wsr_cv_read(cv, &byte, 1) == 1 && wsr_cv_write(cv, &byte, 1, at) != 0) {
+    perror("Error writing output");
+    return -1;
+  }
+  return 0;
+}
+
+/* Chunks whose numeric fields are known to the decoders. */
+int wsr_cv_known(uint32_t ck_id) {
+  switch (ck_id) {
+  case ACID_CODE:
+  case BEXT_CODE:
+  case DISP_CODE:
+  case FACT_CODE:
+  case FMT_CODE:
+  case LEVL_CODE:
+  case LIST_CODE:
+    return 1;
+  default:
+    /* INST and MD5 are byte fields, everything else is passed through. */
+    return 0;
+  }
+}
+
+/* True for the PCM and float sub-formats, plain and B-format ambisonic.
+   `guid` is in RIFF layout, the format code is its first field. */
+int wsr_cv_sample_guid(const uint8_t *guid) {
+  static const uint8_t ksdataformat[12] = {0x00, 0x00, 0x10, 0x00,
+                                           0x80, 0x00, 0x00, 0xAA,
+                                           0x00, 0x38, 0x9B, 0x71};
+  static const uint8_t ambisonic[12] = {0x21, 0x07, 0xD3, 0x11,
+                                        0x86, 0x44, 0xC8, 0xC1,
+                                        0xCA, 0x00, 0x00, 0x00};
+  uint32_t code;
+  memcpy(&code, guid, sizeof(code));
+  if (code != WSR_FORMAT_PCM && code != WSR_FORMAT_IEEE_FLOAT) {
+    return 0;
+  }
+  return memcmp(guid + 4, ksdataformat, 12) == 0 ||
+         memcmp(guid + 4, ambisonic, 12) == 0;
+}
+
+/* Convert every known field of a buffered chunk to little-endian. */
+void wsr_cv_fields(wsr_converter *cv, uint32_t ck_id, uint8_t *data,
+                   size_t ck_size) {
+  wsr_cursor cur = {data, ck_size, 0};
+
+  switch (ck_id) {
+  case ACID_CODE: {
+    wsr_cv_swap(&cur, 4); /* Properties. */
+    wsr_cv_swap(&cur, 2); /* Root note. */
+    wsr_cv_swap(&cur, 2); /* Unknown 1. */
+    wsr_cv_swap(&cur, 4); /* Unknown 2. */
+    wsr_cv_swap(&cur, 4); /* Beat count. */
+    wsr_cv_swap(&cur, 2); /* Meter numerator. */
+    wsr_cv_swap(&cur, 2); /* Meter denominator. */
+    wsr_cv_swap(&cur, 4); /* Tempo. */
+    break;
+  }
+
+  case BEXT_CODE: {
+    /* Description, originator, originator reference, date and time. */
+    wsr_cv_skip(&cur, 256 + 32 + 32 + 10 + 8);
+    wsr_cv_swap(&cur, 4);  /* Time reference low. */
+    wsr_cv_swap(&cur, 4);  /* Time reference high. */
+    wsr_cv_swap(&cur, 2);  /* Version. */
+    wsr_cv_skip(&cur, 64); /* SMPTE umid. */
+    wsr_cv_swap(&cur, 2);  /* Loudness value. */
+    wsr_cv_swap(&cur, 2);  /* Loudness range. */
+    wsr_cv_swap(&cur, 2);  /* Max true peak level. */
+    wsr_cv_swap(&cur, 2);  /* Max momentary loudness. */
+    wsr_cv_swap(&cur, 2);  /* Max short term loudness. */
+    /* Reserved and coding history are text. */
+    break;
+  }
+
+  case DISP_CODE: {
+    wsr_cv_swap(&cur, 4); /* CF type, CF data is left as is. */
+    break;
+  }
+
+  case FACT_CODE: {
+    wsr_cv_swap(&cur, 4); /* Samples. */
+    break;
+  }
+
+  case FMT_CODE: {
+    uint16_t audio_format = wsr_cv_swap(&cur, 2);
+    cv->audio_format = audio_format;
+    cv->swap_data = audio_format == WSR_FORMAT_PCM ||
+                    audio_format == WSR_FORMAT_IEEE_FLOAT;
+    cv->num_channels = wsr_cv_swap(&cur, 2);
+    wsr_cv_swap(&cur, 4); /* Sample rate. */
+    wsr_cv_swap(&cur, 4); /* Byte rate. */
+    cv->block_align = wsr_cv_swap(&cur, 2);
+    cv->bits_per_sample = wsr_cv_swap(&cur, 2);
+
+    if (ck_size > 16) {
+      wsr_cv_swap(&cur, 2); /* Extension size. */
+    }
+
+    if (audio_format == EXTENSIBLE) {
+      wsr_cv_swap(&cur, 2); /* Valid bits per sample. */
+      wsr_cv_swap(&cur, 4); /* Channel mask. */
+
+      /* Sub-format GUID, its first three fields are integers. */
+      size_t guid_pos = cur.pos;
+      wsr_cv_swap(&cur, 4);
+      wsr_cv_swap(&cur, 2);
+      wsr_cv_swap(&cur, 2);
+      wsr_cv_skip(&cur, 8);
+
+      /* Compared in RIFF layout, as the decoder reads it. */
+      char guid_str[37] = "";
+      cv->swap_data = 0;
+      if (guid_pos + sizeof(uuid_t) <= cur.size) {
+        uuid_unparse(data + guid_pos, guid_str);
+        cv->swap_data = wsr_cv_sample_guid(data + guid_pos);
+      }
+
+      if (strcasecmp(guid_str, MSGUID_SUBTYPE_PVOCEX) == 0 && ck_size == 80) {
+        cv->swap_data = 1; /* Analysis frames are float words. */
+        wsr_cv_swap(&cur, 4); /* Version. */
+        wsr_cv_swap(&cur, 4); /* PVOC-EX size. */
+        wsr_cv_swap(&cur, 2); /* Word format. */
+        wsr_cv_swap(&cur, 2); /* Analysis format. */
+        wsr_cv_swap(&cur, 2); /* Source format. */
+        wsr_cv_swap(&cur, 2); /* Window type. */
+        wsr_cv_swap(&cur, 4); /* Bin count. */
+        wsr_cv_swap(&cur, 4); /* Window length. */
+        wsr_cv_swap(&cur, 4); /* Overlap. */
+        wsr_cv_swap(&cur, 4); /* Frame align. */
+        wsr_cv_swap(&cur, 4); /* Analysis rate. */
+        wsr_cv_swap(&cur, 4); /* Window parameter. */
+      }
+    }
+    break;
+  }
+
+  case LEVL_CODE: {
+    wsr_cv_swap(&cur, 4); /* Version. */
+    uint32_t format = wsr_cv_swap(&cur, 4);
+    wsr_cv_swap(&cur, 4); /* Points per value. */
+    wsr_cv_swap(&cur, 4); /* Block size. */
+    wsr_cv_swap(&cur, 4); /* Channel count. */
+    wsr_cv_swap(&cur, 4); /* Frame count. */
+    wsr_cv_swap(&cur, 4); /* Position. */
+    wsr_cv_swap(&cur, 4); /* Offset. */
+    wsr_cv_skip(&cur, 28 + 60); /* Timestamp and reserved. */
+
+    /* Peak envelope points are 8-bit (format 1) or 16-bit (format 2). */
+    if (format == 2 && cur.pos < cur.size) {
+      wsr_bswap_samples(data + cur.pos, cur.size - cur.pos, 2);
+    }
+    break;
+  }
+
+  case LIST_CODE: {
+    wsr_cv_skip(&cur, 4); /* List type. */
+
+    /* Tag identifiers are bytes, only the (padded) sizes are numeric. */
+    while (cur.pos + 8 <= cur.size) {
+      wsr_cv_skip(&cur, 4);
+      uint32_t t_size = wsr_cv_swap(&cur, 4);
+      wsr_cv_skip(&cur, (size_t)t_size + t_size % 2);
+    }
+    break;
+  }
+
+  default:
+    break;
+  }
+}
+
+/* State of the read-only pass made before anything is written. */
+typedef struct {
+  long file_size;
+  int fmt_seen;
+  uint16_t block_align;
+  uint16_t bits_per_sample;
+} wsr_cv_check;
+
+/* Reject files the conversion would fail on part way, so nothing (the
+   master header in particular) is rewritten for them. */
+int wsr_cv_check_ck(FILE *fp, const wsr_riff *riff, const wsr_chunk *ck,
+                    void *ctx) {
+  wsr_cv_check *check = ctx;
+
+  if (ck->offset + (long)ck->size > check->file_size) {
+    fprintf(stderr, "Chunk %.4s extends past the end of the file. Exiting.\n",
+            (const char *)&ck->id);
+    return -1;
+  }
+
+  if (ck->id == FMT_CODE && ck->size >= 16) {
+    check->fmt_seen = 1;
+    fseek(fp, ck->offset + 12, SEEK_SET);
+    wsr_fread(&check->block_align, 2, 1, fp, riff->endianness);
+    wsr_fread(&check->bits_per_sample, 2, 1, fp, riff->endianness);
+  } else if (ck->id == DATA_CODE && !check->fmt_seen) {
+    fprintf(stderr, "data chunk found before fmt chunk. Exiting.\n");
+    return -1;
+  } else if (ck->id == DATA_CODE && check->block_align == 0 &&
+             check->bits_per_sample == 0) {
+    fprintf(stderr, "fmt chunk has no block align or bits per sample. "
+                    "Exiting.\n");
+    return -1;
+  }
+  return 0;
+}
+
+/* Convert one chunk, called by wsr_walk with `in` at the chunk data. */
+int wsr_cv_chunk(FILE *fp, const wsr_riff *riff, const wsr_chunk *ck,
+                 void *ctx) {
+  (void)fp;
+  (void)riff;
+  wsr_converter *cv = ctx;
+  uint8_t *block = cv->block;
+
+  uint32_t header[2] = {ck->id, ck->size};
+  if (wsr_cv_write(cv, header, sizeof(header), ck->offset - 8) != 0) {
+    perror("Error writing output");
+    return -1;
+  }
+  cv->pos = ck->offset;
+
+  if (ck->id == DATA_CODE) {
+    size_t width = cv->num_channels ? cv->block_align / cv->num_channels : 0;
+    if (width == 0) {
+      width = (cv->bits_per_sample + 7) / 8;
+    }
+
+    /* Compressed data is not a sequence of words, leave it alone. */
+    if (!cv->swap_data) {
+      fprintf(stderr, "Audio format %hu is not PCM or float, "
+                      "data copied unchanged.\n", cv->audio_format);
+      width = 0;
+    }
+
+    /* Large payloads are split across threads when the files allow
+       positioned I/O, pipes and small chunks are streamed serially. */
+    unsigned threads = width > 1 ? wsr_parallel_threads(ck->size) : 1;
+    int failed = threads > 1 && wsr_cv_direct(cv, cv->pos)
+                     ? wsr_cv_parallel(cv, ck->size, width, threads)
+                     : wsr_cv_stream(cv, block, ck->size, width);
+    if (failed) {
+      return -1;
+    }
+  } else if (wsr_cv_known(ck->id)) {
+    size_t size = ck->size;
+    uint8_t *data = size <= WSR_CONVERT_BLOCK ? block : malloc(size);
+    if (data == NULL) {
+      perror("Error allocating buffer");
+      return -1;
+    }
+
+    int failed = wsr_cv_read(cv, data, size) != size;
+    if (failed) {
+      fprintf(stderr, "Unexpected end of file at offset %ld.\n", cv->pos);
+    } else {
+      wsr_cv_fields(cv, ck->id, data, size);
+      failed = wsr_cv_write(cv, data, size, ck->offset) != 0;
+      if (failed) {
+        perror("Error writing output");
+      }
+    }
+
+    if (data != block) {
+      free(data);
+    }
+    if (failed) {
+      return -1;
+    }
+  } else if (wsr_cv_stream(cv, block, ck->size, 0) != 0) {
+    return -1; /* Generic or unsupported chunk, copied as is. */
+  }
+
+  return wsr_cv_pad(cv, ck->pad);
+}
+
+/* Convert a RIFX/FFIR file to RIFF. Pass the same stream (or NULL) as
+   `out` to convert in place. Layout problems are caught before the first
+   write, only I/O errors can leave an in-place conversion half done. */
+int wsr_convert(FILE *in, FILE *out) {
+  wsr_converter cv = {in, out ? out : in, 0, 0, 0, 0, 0, 0, NULL};
+  int status = -1;
+
+  cv.block = malloc(WSR_CONVERT_BLOCK);
+  if (cv.block == NULL) {
+    perror("Error allocating buffer");
+    return -1;
+  }
+
+  wsr_riff riff;
+  if (wsr_open(in, &riff) != 0) {
+    fprintf(stderr, "%s. Exiting.\n", riff.error);
+    goto done;
+  }
+
+  uint32_t header[3] = {riff.master, riff.fsize, riff.ftype};
+  cv.pos = sizeof(header);
+
+  if (riff.endianness == ENDIAN_LITTLE) {
+    fprintf(stderr, "File is already little-endian, copying unchanged.\n");
+    if (cv.in == cv.out ||
+        wsr_cv_write(&cv, header, sizeof(header), 0) == 0) {
+      status = wsr_cv_copy_rest(&cv, cv.block);
+    }
+    goto done;
+  }
+
+  struct stat st;
+  wsr_cv_check check = {0, 0, 0, 0};
+  if (fstat(fileno(in), &st) != 0) {
+    perror("Error reading file");
+    goto done;
+  }
+  check.file_size = (long)st.st_size;
+  if (wsr_walk(in, &riff, wsr_cv_check_ck, &check) != 0) {
+    goto done;
+  }
+
+  header[0] = RIFF_CODE;
+  if (wsr_cv_write(&cv, header, sizeof(header), 0) != 0) {
+    perror("Error writing output");
+    goto done;
+  }
+
+  if (wsr_walk(in, &riff, wsr_cv_chunk, &cv) == 0) {
+    status = wsr_cv_copy_rest(&cv, cv.block);
+  }
+
+done:
+  free(cv.block);
+  if (status == 0 && fflush(cv.out) != 0) {
+    perror("Error writing output");
+    status = -1;
+  }
+  return status;
+}
+
+#endif // WAVE_STRUCTURE_CONVERTER_H
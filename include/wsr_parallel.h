@@ -0,0 +1,171 @@
+#ifndef WAVE_STRUCTURE_PARALLEL_H
+#define WAVE_STRUCTURE_PARALLEL_H
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+/* Per-thread I/O window, matches the serial streaming block. */
+#define WSR_PARALLEL_BLOCK (1 << 20)
+
+/* Payloads are not split below this size per thread. */
+#define WSR_PARALLEL_MIN_RANGE (16 << 20)
+
+#define WSR_PARALLEL_MAX_THREADS 64
+
+typedef struct wsr_range wsr_range;
+
+/* Processes `len` bytes of a range, `buf` is written back if out_fd >= 0. */
+typedef void (*wsr_range_fn)(wsr_range *range, uint8_t *buf, size_t len);
+
+/* A frame-aligned slice of a data chunk handled by one thread. */
+struct wsr_range {
+  int in_fd;
+  int out_fd;          /* -1 for read-only (analysis) passes. */
+  off_t offset;        /* Absolute file offset of the slice. */
+  uint64_t size;
+  size_t frame;        /* Blocks never split a frame. */
+  wsr_range_fn kernel;
+  const void *arg;     /* Shared pass parameters. */
+  void *state;         /* Per-range result, merged in range order. */
+  int status;          /* 0, or -1 with error_at and error set. */
+  off_t error_at;
+  int error;           /* errno, 0 on unexpected end of file. */
+  pthread_t thread;
+};
+
+/* Number of threads worth using for a payload of `size` bytes. */
+unsigned wsr_parallel_threads(uint64_t size) {
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  if (cpus < 1) {
+    cpus = 1;
+  }
+  if (cpus > WSR_PARALLEL_MAX_THREADS) {
+    cpus = WSR_PARALLEL_MAX_THREADS;
+  }
+
+  uint64_t ranges = size / WSR_PARALLEL_MIN_RANGE;
+  if (ranges < 1) {
+    ranges = 1;
+  }
+  return ranges < (uint64_t)cpus ? (unsigned)ranges : (unsigned)cpus;
+}
+
+/* Split `size` bytes at `offset` into `count` frame-aligned ranges. The
+   last range also takes any trailing partial frame. */
+int wsr_split_ranges(wsr_range *ranges, unsigned count, off_t offset,
+                     uint64_t size, size_t frame) {
+  if (frame == 0 || count == 0) {
+    return -1;
+  }
+
+  uint64_t frames = size / frame;
+  uint64_t per_range = frames / count;
+  uint64_t extra = frames % count;
+
+  for (unsigned i = 0; i < count; i++) {
+    uint64_t range_frames = per_range + (i < extra ? 1 : 0);
+    ranges[i].offset = offset;
+    ranges[i].size = range_frames * frame;
+    ranges[i].frame = frame;
+    offset += ranges[i].size;
+  }
+  ranges[count - 1].size += size % frame;
+  return 0;
+}
+
+/* Thread body, streams one range through its kernel with pread/pwrite. */
+void *wsr_range_worker(void *arg) {
+  wsr_range *range = arg;
+  range->status = 0;
+
+  size_t block_size = WSR_PARALLEL_BLOCK - WSR_PARALLEL_BLOCK % range->frame;
+  if (block_size == 0) {
+    block_size = range->frame;
+  }
+
+  uint8_t *block = malloc(block_size);
+  if (block == NULL) {
+    range->status = -1;
+    range->error_at = range->offset;
+    range->error = ENOMEM;
+    return NULL;
+  }
+
+  uint64_t done = 0;
+  while (done < range->size) {
+    uint64_t left = range->size - done;
+    size_t want = left < block_size ? (size_t)left : block_size;
+    off_t at = range->offset + (off_t)done;
+
+    size_t got = 0;
+    while (got < want) {
+      ssize_t n = pread(range->in_fd, block + got, want - got, at + got);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n <= 0) {
+        range->status = -1;
+        range->error_at = at + (off_t)got;
+        range->error = n < 0 ? errno : 0;
+        free(block);
+        return NULL;
+      }
+      got += (size_t)n;
+    }
+
+    range->kernel(range, block, want);
+
+    size_t put = 0;
+    while (range->out_fd >= 0 && put < want) {
+      ssize_t n = pwrite(range->out_fd, block + put, want - put, at + put);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n <= 0) {
+        range->status = -1;
+        range->error_at = at + (off_t)put;
+        range->error = n < 0 ? errno : EIO;
+        free(block);
+        return NULL;
+      }
+      put += (size_t)n;
+    }
+
+    done += want;
+  }
+
+  free(block);
+  return NULL;
+}
+
+/* Run every range on its own thread and wait for all of them. Ranges that
+   could not get a thread run on the caller. Results are left in `ranges`
+   for the caller to merge in order. Returns -1 if any range failed. */
+int wsr_run_ranges(wsr_range *ranges, unsigned count) {
+  int started[WSR_PARALLEL_MAX_THREADS] = {0};
+
+  for (unsigned i = 1; i < count; i++) {
+    started[i] = pthread_create(&ranges[i].thread, NULL, wsr_range_worker,
+                                &ranges[i]) == 0;
+  }
+  wsr_range_worker(&ranges[0]);
+
+  int status = ranges[0].status;
+  for (unsigned i = 1; i < count; i++) {
+    if (started[i]) {
+      pthread_join(ranges[i].thread, NULL);
+    } else {
+      wsr_range_worker(&ranges[i]);
+    }
+    if (ranges[i].status != 0) {
+      status = -1;
+    }
+  }
+  return status;
+}
+
+#endif // WAVE_STRUCTURE_PARALLEL_H
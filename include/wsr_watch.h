@@ -0,0 +1,743 @@
+#ifndef WAVE_STRUCTURE_WATCH_H
+#define WAVE_STRUCTURE_WATCH_H
+
+#include "wsr.h"
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+  #include <sys/inotify.h>
+#endif
+
+#ifdef __APPLE__
+  #define WSR_MTIME_NS(st) ((int64_t)(st)->st_mtimespec.tv_sec * 1000000000 + (st)->st_mtimespec.tv_nsec)
+#else
+  #define WSR_MTIME_NS(st) ((int64_t)(st)->st_mtim.tv_sec * 1000000000 + (st)->st_mtim.tv_nsec)
+#endif
+
+/* Quiet period after the last write before a file is parsed. */
+#define WSR_WATCH_DEBOUNCE_MS 500
+
+/* Tree walk interval when inotify is unavailable. */
+#define WSR_WATCH_POLL_MS 2000
+
+/* Bounded work queue and pending set, events past the limit are dropped
+   and recovered by a rescan once the backlog has drained. */
+#define WSR_WATCH_QUEUE       1024
+#define WSR_WATCH_MAX_PENDING 65536
+#define WSR_WATCH_MAX_WORKERS 8
+
+#define WSR_WATCH_MAX_CHUNKS 32
+
+/* Header fields of a WAVE file, gathered without printing. */
+typedef struct {
+  uint32_t master;
+  ENDIAN endianness;
+  uint16_t audio_format;
+  uint16_t num_channels;
+  uint32_t sample_rate;
+  uint16_t block_align;
+  uint16_t bits_per_sample;
+  uint32_t data_size;
+  uint32_t chunks[WSR_WATCH_MAX_CHUNKS];
+  int chunk_count;
+  const char *error;
+} wsr_summary;
+
+typedef enum {
+  WSR_IDLE = 0,
+  WSR_PENDING = 1,
+  WSR_QUEUED = 2,
+  WSR_BUSY = 3
+} WSR_ENTRY_STATE;
+
+/* One watched file, both index record and pending work item. */
+typedef struct wsr_entry {
+  char *path;
+  struct wsr_entry *next; /* Hash chain. */
+  struct wsr_entry *prev_pending;
+  struct wsr_entry *next_pending;
+  WSR_ENTRY_STATE state;
+  int dirty;       /* Touched again while queued or busy. */
+  int indexed;     /* An added event has been emitted. */
+  off_t size;      /* Indexed size and mtime. */
+  int64_t mtime;
+  off_t seen_size; /* Last size and mtime observed by a rescan. */
+  int64_t seen_mtime;
+  unsigned seen;   /* Rescan generation. */
+  uint64_t deadline;
+} wsr_entry;
+
+typedef struct {
+  char root[PATH_MAX];
+  int fd; /* inotify descriptor, -1 when polling. */
+  int poll; /* A directory could not be watched, rescan periodically. */
+  char **wd_paths;
+  int wd_cap;
+
+  pthread_mutex_t lock; /* Guards everything below. */
+  pthread_cond_t ready;
+  wsr_entry **buckets;
+  size_t nbuckets;
+  size_t count;
+  wsr_entry *pending_head; /* Sorted by deadline. */
+  wsr_entry *pending_tail;
+  size_t pending_count;
+  wsr_entry *queue[WSR_WATCH_QUEUE];
+  size_t q_head;
+  size_t q_len;
+  int overflow;
+  unsigned generation;
+  uint64_t delay; /* Quiet period before a file is parsed, see wsr_watch. */
+} wsr_watcher;
+
+/* Record a chunk header, called by wsr_walk. */
+int wsr_scan_ck(FILE *fp, const wsr_riff *riff, const wsr_chunk *ck,
+                void *ctx) {
+  wsr_summary *s = ctx;
+
+  if (s->chunk_count < WSR_WATCH_MAX_CHUNKS) {
+    s->chunks[s->chunk_count++] = ck->id;
+  }
+
+  if (ck->id == FMT_CODE && ck->size >= 16) {
+    uint32_t byte_rate;
+    wsr_fread(&s->audio_format, 2, 1, fp, riff->endianness);
+    wsr_fread(&s->num_channels, 2, 1, fp, riff->endianness);
+    wsr_fread(&s->sample_rate, 4, 1, fp, riff->endianness);
+    wsr_fread(&byte_rate, 4, 1, fp, riff->endianness);
+    wsr_fread(&s->block_align, 2, 1, fp, riff->endianness);
+    wsr_fread(&s->bits_per_sample, 2, 1, fp, riff->endianness);
+  } else if (ck->id == DATA_CODE) {
+    s->data_size = ck->size;
+  }
+  return 0;
+}
+
+/* Collect the header fields of a WAVE file without printing. */
+int wsr_scan(FILE *fp, wsr_summary *s) {
+  memset(s, 0, sizeof(*s));
+
+  wsr_riff riff;
+  if (wsr_open(fp, &riff) != 0) {
+    s->master = riff.master;
+    s->error = riff.error;
+    return -1;
+  }
+  s->master = riff.master;
+  s->endianness = riff.endianness;
+  return wsr_walk(fp, &riff, wsr_scan_ck, s);
+}
+
+uint64_t wsr_now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+/* Only WAVE extensions are indexed, hidden files are usually partials. */
+int wsr_is_wave(const char *name) {
+  const char *ext = strrchr(name, '.');
+  if (name[0] == '.' || ext == NULL) {
+    return 0;
+  }
+  ext++;
+  return strcasecmp(ext, "wav") == 0 || strcasecmp(ext, "wave") == 0 ||
+         strcasecmp(ext, "bwf") == 0 || strcasecmp(ext, "rf64") == 0;
+}
+
+/* Write a JSON string literal. */
+void wsr_json_str(FILE *out, const char *s, size_t len) {
+  fputc('"', out);
+  for (size_t i = 0; i < len; i++) {
+    unsigned char c = s[i];
+    if (c == '"' || c == '\\') {
+      fprintf(out, "\\%c", c);
+    } else if (c < 0x20 || c == 0x7F) {
+      fprintf(out, "\\u%04x", c);
+    } else {
+      fputc(c, out);
+    }
+  }
+  fputc('"', out);
+}
+
+void wsr_json_4cc(FILE *out, uint32_t code) {
+  char s[4] = {code & 0xFF, (code >> 8) & 0xFF, (code >> 16) & 0xFF,
+               (code >> 24) & 0xFF};
+  wsr_json_str(out, s, sizeof(s));
+}
+
+/* Emit one NDJSON event line, `st` and `s` are NULL for removals. */
+void wsr_watch_emit(const char *event, const char *path, const struct stat *st,
+                    const wsr_summary *s) {
+  flockfile(stdout);
+  printf("{\"event\":\"%s\",\"path\":", event);
+  wsr_json_str(stdout, path, strlen(path));
+
+  if (st != NULL) {
+    printf(",\"size\":%lld,\"mtime\":%lld", (long long)st->st_size,
+           (long long)(WSR_MTIME_NS(st) / 1000000000));
+  }
+
+  if (s != NULL && s->error != NULL) {
+    printf(",\"error\":");
+    wsr_json_str(stdout, s->error, strlen(s->error));
+  } else if (s != NULL) {
+    printf(",\"master\":");
+    wsr_json_4cc(stdout, s->master);
+    printf(",\"endianness\":\"%s\"",
+           s->endianness == ENDIAN_LITTLE ? "LITTLE_ENDIAN" : "BIG_ENDIAN");
+    printf(",\"audio_format\":%u,\"channels\":%u,\"sample_rate\":%u"
+           ",\"block_align\":%u,\"bits_per_sample\":%u,\"data_size\":%u",
+           s->audio_format, s->num_channels, s->sample_rate, s->block_align,
+           s->bits_per_sample, s->data_size);
+    printf(",\"chunks\":[");
+    for (int i = 0; i < s->chunk_count; i++) {
+      if (i > 0) {
+        putchar(',');
+      }
+      wsr_json_4cc(stdout, s->chunks[i]);
+    }
+    putchar(']');
+  }
+
+  printf("}\n");
+  fflush(stdout);
+  funlockfile(stdout);
+}
+
+/* FNV-1a. */
+size_t wsr_hash(const char *s) {
+  uint64_t h = 14695981039346656037ULL;
+  while (*s) {
+    h = (h ^ (unsigned char)*s++) * 1099511628211ULL;
+  }
+  return (size_t)h;
+}
+
+/* Grow the index so chains stay short. Lock held. */
+void wsr_watch_rehash(wsr_watcher *w) {
+  size_t nbuckets = w->nbuckets * 2;
+  wsr_entry **buckets = calloc(nbuckets, sizeof(*buckets));
+  if (buckets == NULL) {
+    return; /* Keep the current table, only slower. */
+  }
+
+  for (size_t i = 0; i < w->nbuckets; i++) {
+    wsr_entry *e = w->buckets[i];
+    while (e != NULL) {
+      wsr_entry *next = e->next;
+      size_t b = wsr_hash(e->path) & (nbuckets - 1);
+      e->next = buckets[b];
+      buckets[b] = e;
+      e = next;
+    }
+  }
+  free(w->buckets);
+  w->buckets = buckets;
+  w->nbuckets = nbuckets;
+}
+
+/* Find the entry for `path`, optionally creating it. Lock held. */
+wsr_entry *wsr_watch_find(wsr_watcher *w, const char *path, int create) {
+  size_t b = wsr_hash(path) & (w->nbuckets - 1);
+  for (wsr_entry *e = w->buckets[b]; e != NULL; e = e->next) {
+    if (strcmp(e->path, path) == 0) {
+      return e;
+    }
+  }
+  if (!create) {
+    return NULL;
+  }
+
+  wsr_entry *e = calloc(1, sizeof(*e));
+  if (e == NULL || (e->path = strdup(path)) == NULL) {
+    free(e);
+    return NULL;
+  }
+  e->next = w->buckets[b];
+  w->buckets[b] = e;
+  if (++w->count > w->nbuckets) {
+    wsr_watch_rehash(w);
+  }
+  return e;
+}
+
+/* Drop an idle entry from the index. Lock held. */
+void wsr_watch_forget(wsr_watcher *w, wsr_entry *entry) {
+  wsr_entry **link = &w->buckets[wsr_hash(entry->path) & (w->nbuckets - 1)];
+  while (*link != entry) {
+    link = &(*link)->next;
+  }
+  *link = entry->next;
+  w->count--;
+  free(entry->path);
+  free(entry);
+}
+
+void wsr_pending_unlink(wsr_watcher *w, wsr_entry *e) {
+  if (e->prev_pending) {
+    e->prev_pending->next_pending = e->next_pending;
+  } else {
+    w->pending_head = e->next_pending;
+  }
+  if (e->next_pending) {
+    e->next_pending->prev_pending = e->prev_pending;
+  } else {
+    w->pending_tail = e->prev_pending;
+  }
+  e->prev_pending = e->next_pending = NULL;
+  w->pending_count--;
+}
+
+/* Every deadline is now + the watcher's delay, so appending keeps the
+   list sorted. Lock held. */
+void wsr_pending_append(wsr_watcher *w, wsr_entry *e) {
+  e->deadline = wsr_now_ms() + w->delay;
+  e->prev_pending = w->pending_tail;
+  e->next_pending = NULL;
+  if (w->pending_tail) {
+    w->pending_tail->next_pending = e;
+  } else {
+    w->pending_head = e;
+  }
+  w->pending_tail = e;
+  w->pending_count++;
+}
+
+/* Schedule `path` to be (re)examined after a quiet period. Lock held. */
+void wsr_watch_touch(wsr_watcher *w, const char *path) {
+  wsr_entry *e =
+      wsr_watch_find(w, path, w->pending_count < WSR_WATCH_MAX_PENDING);
+  if (e == NULL) {
+    w->overflow = 1;
+    return;
+  }
+
+  switch (e->state) {
+  case WSR_IDLE:
+    if (w->pending_count >= WSR_WATCH_MAX_PENDING) {
+      w->overflow = 1;
+      if (!e->indexed) {
+        wsr_watch_forget(w, e);
+      }
+      return;
+    }
+    e->state = WSR_PENDING;
+    break;
+  case WSR_PENDING:
+    wsr_pending_unlink(w, e); /* Restart the quiet period. */
+    break;
+  case WSR_QUEUED:
+  case WSR_BUSY:
+    e->dirty = 1; /* Picked up again once the worker is done. */
+    return;
+  }
+  wsr_pending_append(w, e);
+}
+
+/* Partial writes only extend files that are already waiting. Lock held. */
+void wsr_watch_extend(wsr_watcher *w, const char *path) {
+  wsr_entry *e = wsr_watch_find(w, path, 0);
+  if (e != NULL && e->state == WSR_PENDING) {
+    wsr_pending_unlink(w, e);
+    wsr_pending_append(w, e);
+  } else if (e != NULL && e->state != WSR_IDLE) {
+    e->dirty = 1;
+  }
+}
+
+/* Move settled files to the work queue. Returns the ms until the next
+   deadline, or -1 when nothing is pending. */
+int wsr_watch_dispatch(wsr_watcher *w) {
+  pthread_mutex_lock(&w->lock);
+  uint64_t now = wsr_now_ms();
+  while (w->pending_head && w->pending_head->deadline <= now &&
+         w->q_len < WSR_WATCH_QUEUE) {
+    wsr_entry *e = w->pending_head;
+    wsr_pending_unlink(w, e);
+    e->state = WSR_QUEUED;
+    w->queue[(w->q_head + w->q_len++) % WSR_WATCH_QUEUE] = e;
+    pthread_cond_signal(&w->ready);
+  }
+
+  int timeout = -1;
+  if (w->pending_head) {
+    /* A full queue is retried shortly instead of blocking on it. */
+    timeout = w->pending_head->deadline <= now
+                  ? 10
+                  : (int)(w->pending_head->deadline - now);
+  }
+  pthread_mutex_unlock(&w->lock);
+  return timeout;
+}
+
+/* Parse one settled file and emit its event. */
+void wsr_watch_process(wsr_watcher *w, wsr_entry *e) {
+  struct stat st;
+  int exists = stat(e->path, &st) == 0 && S_ISREG(st.st_mode);
+
+  pthread_mutex_lock(&w->lock);
+  int indexed = e->indexed;
+  int same = indexed && exists && e->size == st.st_size &&
+             e->mtime == WSR_MTIME_NS(&st);
+  pthread_mutex_unlock(&w->lock);
+
+  if (!exists && indexed) {
+    wsr_watch_emit("removed", e->path, NULL, NULL);
+  } else if (exists && !same) {
+    wsr_summary s;
+    FILE *fp = fopen(e->path, "rb");
+    if (fp == NULL) {
+      memset(&s, 0, sizeof(s));
+      s.error = strerror(errno);
+    } else {
+      wsr_scan(fp, &s);
+      fclose(fp);
+    }
+    wsr_watch_emit(indexed ? "changed" : "added", e->path, &st, &s);
+  }
+
+  pthread_mutex_lock(&w->lock);
+  e->indexed = exists;
+  if (exists) {
+    e->size = st.st_size;
+    e->mtime = WSR_MTIME_NS(&st);
+  }
+
+  if (e->dirty) {
+    e->dirty = 0;
+    e->state = WSR_PENDING;
+    wsr_pending_append(w, e);
+  } else {
+    e->state = WSR_IDLE;
+    if (!exists) {
+      wsr_watch_forget(w, e);
+    }
+  }
+  pthread_mutex_unlock(&w->lock);
+}
+
+void *wsr_watch_worker(void *arg) {
+  wsr_watcher *w = arg;
+  for (;;) {
+    pthread_mutex_lock(&w->lock);
+    while (w->q_len == 0) {
+      pthread_cond_wait(&w->ready, &w->lock);
+    }
+    wsr_entry *e = w->queue[w->q_head];
+    w->q_head = (w->q_head + 1) % WSR_WATCH_QUEUE;
+    w->q_len--;
+    e->state = WSR_BUSY; /* The entry stays alive until we release it. */
+    pthread_mutex_unlock(&w->lock);
+
+    wsr_watch_process(w, e);
+  }
+  return NULL;
+}
+
+/* Watch a directory, remembering its path for event names. */
+void wsr_watch_add_dir(wsr_watcher *w, const char *dir) {
+#ifdef __linux__
+  if (w->fd < 0) {
+    return;
+  }
+
+  int wd = inotify_add_watch(w->fd, dir,
+                             IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM |
+                                 IN_DELETE | IN_MODIFY | IN_CREATE |
+                                 IN_ONLYDIR);
+  if (wd < 0) {
+    /* Out of watches (ENOSPC) or similar, poll for what events miss. The
+       delay only grows, so the pending list stays sorted. */
+    if (!w->poll) {
+      fprintf(stderr, "Cannot watch %s: %s, polling every %d ms.\n", dir,
+              strerror(errno), WSR_WATCH_POLL_MS);
+    }
+    w->poll = 1;
+    pthread_mutex_lock(&w->lock);
+    w->delay = WSR_WATCH_POLL_MS + WSR_WATCH_DEBOUNCE_MS;
+    pthread_mutex_unlock(&w->lock);
+    return;
+  }
+
+  if (wd >= w->wd_cap) {
+    int cap = w->wd_cap ? w->wd_cap : 64;
+    while (cap <= wd) {
+      cap *= 2;
+    }
+    char **paths = realloc(w->wd_paths, cap * sizeof(*paths));
+    if (paths == NULL) {
+      return;
+    }
+    memset(paths + w->wd_cap, 0, (cap - w->wd_cap) * sizeof(*paths));
+    w->wd_paths = paths;
+    w->wd_cap = cap;
+  }
+
+  /* A moved directory keeps its descriptor, so the path is refreshed. */
+  free(w->wd_paths[wd]);
+  w->wd_paths[wd] = strdup(dir);
+#else
+  (void)w;
+  (void)dir;
+#endif
+}
+
+/* Walk `dir`, watching subdirectories and touching new or changed files. */
+void wsr_watch_walk(wsr_watcher *w, const char *dir) {
+  DIR *d = opendir(dir);
+  if (d == NULL) {
+    return;
+  }
+  wsr_watch_add_dir(w, dir);
+
+  struct dirent *de;
+  while ((de = readdir(d)) != NULL) {
+    if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0) {
+      continue;
+    }
+
+    char path[PATH_MAX];
+    if (snprintf(path, sizeof(path), "%s/%s", dir, de->d_name) >=
+        (int)sizeof(path)) {
+      continue;
+    }
+
+    struct stat st;
+    if (lstat(path, &st) != 0) {
+      continue;
+    }
+    if (S_ISDIR(st.st_mode)) {
+      wsr_watch_walk(w, path);
+      continue;
+    }
+    if (!S_ISREG(st.st_mode) || !wsr_is_wave(de->d_name)) {
+      continue;
+    }
+
+    pthread_mutex_lock(&w->lock);
+    wsr_entry *e = wsr_watch_find(w, path, 0);
+    int64_t mtime = WSR_MTIME_NS(&st);
+    if (e != NULL) {
+      e->seen = w->generation;
+    }
+
+    int observed = e != NULL && e->seen_size == st.st_size &&
+                   e->seen_mtime == mtime;
+    int indexed = e != NULL && e->indexed && e->size == st.st_size &&
+                  e->mtime == mtime;
+    /* Waiting files are only restarted when they are still growing. */
+    if (!indexed && !(observed && e->state != WSR_IDLE)) {
+      wsr_watch_touch(w, path);
+      e = wsr_watch_find(w, path, 0);
+      if (e != NULL) {
+        e->seen = w->generation;
+        e->seen_size = st.st_size;
+        e->seen_mtime = mtime;
+      }
+    }
+    pthread_mutex_unlock(&w->lock);
+  }
+  closedir(d);
+}
+
+/* Full walk of the tree, used at startup, after dropped events and as the
+   polling fallback. Indexed files that were not seen are re-checked. */
+void wsr_watch_rescan(wsr_watcher *w) {
+  pthread_mutex_lock(&w->lock);
+  w->overflow = 0;
+  w->generation++;
+  pthread_mutex_unlock(&w->lock);
+
+  wsr_watch_walk(w, w->root);
+
+  pthread_mutex_lock(&w->lock);
+  for (size_t i = 0; i < w->nbuckets; i++) {
+    wsr_entry *e = w->buckets[i];
+    while (e != NULL) {
+      wsr_entry *next = e->next; /* Touch may forget the entry. */
+      if (e->indexed && e->seen != w->generation && e->state == WSR_IDLE) {
+        wsr_watch_touch(w, e->path);
+      }
+      e = next;
+    }
+  }
+  pthread_mutex_unlock(&w->lock);
+}
+
+#ifdef __linux__
+/* Translate one batch of inotify events into touches. */
+void wsr_watch_events(wsr_watcher *w, const char *buf, ssize_t len) {
+  const struct inotify_event *ev;
+  for (const char *p = buf; p < buf + len; p += sizeof(*ev) + ev->len) {
+    ev = (const struct inotify_event *)p;
+
+    if (ev->mask & IN_Q_OVERFLOW) {
+      pthread_mutex_lock(&w->lock);
+      w->overflow = 1;
+      pthread_mutex_unlock(&w->lock);
+      continue;
+    }
+    if (ev->wd < 0 || ev->wd >= w->wd_cap || w->wd_paths[ev->wd] == NULL) {
+      continue;
+    }
+    if (ev->mask & IN_IGNORED) {
+      free(w->wd_paths[ev->wd]);
+      w->wd_paths[ev->wd] = NULL;
+      continue;
+    }
+    if (ev->len == 0) {
+      continue;
+    }
+
+    char path[PATH_MAX];
+    if (snprintf(path, sizeof(path), "%s/%s", w->wd_paths[ev->wd],
+                 ev->name) >= (int)sizeof(path)) {
+      continue;
+    }
+
+    if (ev->mask & IN_ISDIR) {
+      if (ev->mask & IN_CREATE) {
+        /* Files may land before the new watch is in place. */
+        wsr_watch_walk(w, path);
+      } else if (ev->mask & (IN_MOVED_FROM | IN_MOVED_TO)) {
+        /* Renamed subtrees change every path below them. */
+        pthread_mutex_lock(&w->lock);
+        w->overflow = 1;
+        pthread_mutex_unlock(&w->lock);
+      }
+      continue;
+    }
+    if (!wsr_is_wave(ev->name)) {
+      continue;
+    }
+
+    pthread_mutex_lock(&w->lock);
+    if (ev->mask & IN_MODIFY) {
+      wsr_watch_extend(w, path);
+    } else if (ev->mask & (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM |
+                           IN_DELETE)) {
+      wsr_watch_touch(w, path);
+    }
+    pthread_mutex_unlock(&w->lock);
+  }
+}
+#endif
+
+/* Watch `root` and stream NDJSON events for added, changed and removed
+   WAVE files. Only returns on setup failure. */
+int wsr_watch(const char *root) {
+  static wsr_watcher w;
+
+  struct stat st;
+  if (stat(root, &st) != 0 || !S_ISDIR(st.st_mode)) {
+    fprintf(stderr, "Not a directory: %s\n", root);
+    return -1;
+  }
+
+  size_t len = strlen(root);
+  while (len > 1 && root[len - 1] == '/') {
+    len--;
+  }
+  if (len >= sizeof(w.root)) {
+    fprintf(stderr, "Path too long: %s\n", root);
+    return -1;
+  }
+  memcpy(w.root, root, len);
+  w.root[len] = '\0';
+
+  w.nbuckets = 1024;
+  w.buckets = calloc(w.nbuckets, sizeof(*w.buckets));
+  if (w.buckets == NULL) {
+    perror("Error allocating index");
+    return -1;
+  }
+  pthread_mutex_init(&w.lock, NULL);
+  pthread_cond_init(&w.ready, NULL);
+
+  w.fd = -1;
+#ifdef __linux__
+  w.fd = inotify_init1(IN_CLOEXEC);
+#endif
+  if (w.fd < 0) {
+    fprintf(stderr, "inotify unavailable, polling every %d ms.\n",
+            WSR_WATCH_POLL_MS);
+  }
+
+  /* Without close events a file must look the same across a whole poll
+     interval before it is parsed. Workers re-queue with the same delay,
+     which wsr_watch_add_dir raises if it has to fall back to polling. */
+  w.delay = w.fd < 0 ? WSR_WATCH_POLL_MS + WSR_WATCH_DEBOUNCE_MS
+                     : WSR_WATCH_DEBOUNCE_MS;
+
+  long workers = sysconf(_SC_NPROCESSORS_ONLN);
+  if (workers < 1) {
+    workers = 1;
+  }
+  if (workers > WSR_WATCH_MAX_WORKERS) {
+    workers = WSR_WATCH_MAX_WORKERS;
+  }
+  for (long i = 0; i < workers; i++) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, wsr_watch_worker, &w) != 0) {
+      perror("Error starting worker");
+      return -1;
+    }
+    pthread_detach(thread);
+  }
+
+  wsr_watch_rescan(&w);
+  uint64_t next_poll = wsr_now_ms() + WSR_WATCH_POLL_MS;
+
+  for (;;) {
+    pthread_mutex_lock(&w.lock);
+    int rescan = w.overflow && w.pending_count < WSR_WATCH_MAX_PENDING / 2;
+    pthread_mutex_unlock(&w.lock);
+
+    int polling = w.fd < 0 || w.poll;
+    uint64_t now = wsr_now_ms();
+    if (rescan || (polling && now >= next_poll)) {
+      wsr_watch_rescan(&w);
+      next_poll = wsr_now_ms() + WSR_WATCH_POLL_MS;
+    }
+
+    int timeout = wsr_watch_dispatch(&w);
+    if (polling || w.overflow) {
+      int until_poll = (int)(next_poll > now ? next_poll - now : 0);
+      if (!polling) {
+        until_poll = 100; /* Waiting for the backlog to drain. */
+      }
+      if (timeout < 0 || timeout > until_poll) {
+        timeout = until_poll;
+      }
+    }
+
+#ifdef __linux__
+    if (w.fd >= 0) {
+      struct pollfd pfd = {w.fd, POLLIN, 0};
+      if (poll(&pfd, 1, timeout) > 0) {
+        char buf[64 * 1024]
+            __attribute__((aligned(__alignof__(struct inotify_event))));
+        ssize_t n = read(w.fd, buf, sizeof(buf));
+        if (n > 0) {
+          wsr_watch_events(&w, buf, n);
+        }
+      }
+      continue;
+    }
+#endif
+    poll(NULL, 0, timeout);
+  }
+}
+
+#endif // WAVE_STRUCTURE_WATCH_H
@@ -1,10 +1,61 @@
 #include "wsr.h"
+#include "wsr_convert.h"
+#include "wsr_watch.h"
 #include <stdint.h>
 #include <stdio.h>
+#include <sys/stat.h>
+
+/* Convert RIFX/FFIR to RIFF, in place when no output path is given. */
+int convert(const char *path, const char *out_path) {
+  FILE *fp = fopen(path, out_path == NULL ? "r+b" : "rb");
+  if (fp == NULL) {
+    perror("Error opening file");
+    return 1;
+  }
+
+  FILE *out = NULL;
+  if (out_path != NULL && strcmp(out_path, "-") == 0) {
+    out = stdout;
+  } else if (out_path != NULL) {
+    /* Opening the input for writing would truncate it before reading. */
+    struct stat in_st, out_st;
+    if (stat(out_path, &out_st) == 0 && fstat(fileno(fp), &in_st) == 0 &&
+        in_st.st_dev == out_st.st_dev && in_st.st_ino == out_st.st_ino) {
+      fclose(fp);
+      return convert(path, NULL);
+    }
+
+    out = fopen(out_path, "wb");
+    if (out == NULL) {
+      perror("Error opening output file");
+      fclose(fp);
+      return 1;
+    }
+  }
+
+  int status = wsr_convert(fp, out);
+  if (out != NULL && out != stdout && fclose(out) != 0) {
+    perror("Error closing output file");
+    status = -1;
+  }
+  fclose(fp);
+  return status == 0 ? 0 : 1;
+}
 
 int main(int argc, char *argv[]) {
+  if (argc >= 3 && argc <= 4 && strcmp(argv[1], "--convert-to-riff") == 0) {
+    return convert(argv[2], argc == 4 ? argv[3] : NULL);
+  }
+
+  if (argc == 3 && strcmp(argv[1], "--watch") == 0) {
+    return wsr_watch(argv[2]) == 0 ? 0 : 1;
+  }
+
   if (argc != 2) {
     fprintf(stderr, "Usage: %s <path>\n", argv[0]);
+    fprintf(stderr, "       %s --convert-to-riff <path> [output|-]\n",
+            argv[0]);
+    fprintf(stderr, "       %s --watch <dir>\n", argv[0]);
     return 1;
   }
 